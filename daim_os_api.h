@@ -14,6 +14,10 @@
 #define MAC_ADDR_LEN 6
 #define ARP_PACKET_LEN 28
 #define DAIM_ETH_II_DATA 0x0700
+#define QUERY_VALUE_LEN 8
+#define PORT_QUEUES_MAX 8
+#define VLAN_PCP_VALUES 8
+#define IP_DSCP_VALUES 64
 
 typedef void (*sighandler) (uint16_t, void *);
 
@@ -32,7 +36,13 @@ enum daim_table {
 	DAIM_SWITCH_CONFIG_TABLE = 0xa9,
 	DAIM_SWITCH_PORT_CONFIG_TABLE = 0xaa,
 	DAIM_ENTITY_CONFIG_TABLE = 0xab,
-	DAIM_LINK_CONFIG_TABLE = 0xac
+	DAIM_LINK_CONFIG_TABLE = 0xac,
+	DAIM_WORKER_TABLE = 0xad,
+	DAIM_WORKER_CONFIG_TABLE = 0xae,
+	DAIM_PORT_QUEUE_TABLE = 0xaf,
+	DAIM_PORT_QOS_CONFIG_TABLE = 0xb0,
+	DAIM_IP_REASM_TABLE = 0xb1,
+	DAIM_IP_REASM_CONFIG_TABLE = 0xb2
 };
 
 /* DAIM OS features */
@@ -40,7 +50,13 @@ enum daim_os_feature {
 	DAIM_SWITCH_STATES = 1 << 0,	/* switch table containing statistics and states*/
     DAIM_PORT_STATES = 1 << 1,		/* port tables containing statistics and states*/
     DAIM_ENTITY_STATES = 1 << 2,	/* entity table containing statistics and states*/
-    DAIM_LINK_STATES = 1 << 3		/* link table containing statistics and states*/
+    DAIM_LINK_STATES = 1 << 3,		/* link table containing statistics and states*/
+    DAIM_TABLE_CURSORS = 1 << 4,	/* per-reader snapshot cursors through daim_cursor_* */
+    DAIM_TABLE_QUERIES = 1 << 5,	/* filtered and projected reads through daim_cursor_query */
+    DAIM_COUNTER_EXPORT = 1 << 6,	/* streaming counter export through daim_export_* */
+    DAIM_WORKER_STATES = 1 << 7,	/* worker tables containing datapath worker statistics and settings */
+    DAIM_PORT_QOS = 1 << 8,			/* egress scheduler with port queue statistics and settings */
+    DAIM_IP_REASM = 1 << 9			/* IP fragment reassembly tables containing statistics and settings */
 };
 
 /* Capabilities of DAIM OS switch */
@@ -96,6 +112,28 @@ enum table_write_op {
     DEL = 0xb               /* delete entries from the table */
 };
 
+/* comparison operators for daim_query_condition */
+enum daim_query_op {
+    QUERY_EQ,           /* field is equal to value */
+    QUERY_NE,           /* field is not equal to value */
+    QUERY_LT,           /* field is less than value */
+    QUERY_LE,           /* field is less than or equal to value */
+    QUERY_GT,           /* field is greater than value */
+    QUERY_GE,           /* field is greater than or equal to value */
+    QUERY_ANY_BITS      /* field has any of the bits set in value, used with state bitmaps */
+};
+
+/* destinations for the counter export */
+enum daim_export_target {
+    EXPORT_SHM_RING,    /* shared memory object holding a daim_counter_ring */
+    EXPORT_FILE         /* file receiving daim_counter_sample records back to back */
+};
+
+/* flags of daim_counter_sample */
+enum daim_counter_sample_flag {
+    SAMPLE_KEYFRAME = 1 << 0    /* counter columns hold absolute values instead of deltas */
+};
+
 /* different settings for DAIM OS switch */
 enum daim_switch_state {
     SWITCH_UP = 1 << 0,		/* the switch is administratively up */
@@ -123,6 +161,32 @@ enum daim_switch_port_state {
 	PORT_ONLY_APP = 1 << 12			/* the port will only forward and receive DAIM applications packets */
 };
 
+/* packet fields hashed to select the worker of a received packet */
+enum daim_worker_hash_field {
+    HASH_IN_PORT = 1 << 0,      /* input DAIM switch port */
+    HASH_MAC_ADDR = 1 << 1,     /* source and destination Ethernet address */
+    HASH_IP_ADDR = 1 << 2,      /* source and destination IP address */
+    HASH_IP_PROTO = 1 << 3,     /* IP protocol */
+    HASH_TP_PORT = 1 << 4       /* TCP/UDP source and destination port, ignored for IP fragments */
+};
+
+/* scheduling discipline of an egress port queue */
+enum daim_queue_scheduling {
+    QUEUE_STRICT = 0xe1,    /* served before any deficit round robin queue, lower queue number first */
+    QUEUE_DRR = 0xe2        /* served by deficit round robin in proportion to weight */
+};
+
+/*
+    handling of IP fragments overlapping data already received for the same datagram
+    the fragment whose data is not kept is dropped and never forwarded, so the receiver cannot reassemble data other than what was matched
+    overlaps touching the first 8 bytes of the TCP/UDP header always drop the whole datagram
+*/
+enum daim_reasm_overlap {
+    REASM_DROP_DATAGRAM = 0xe3,     /* drop the whole datagram */
+    REASM_KEEP_FIRST = 0xe4,        /* keep previously received fragments and drop the overlapping fragment */
+    REASM_KEEP_LAST = 0xe5          /* keep the overlapping fragment and drop the previously received fragments it overlaps */
+};
+
 /* different settings for DAIM OS switch link */
 enum switch_link_state {
     LINK_UP = 1 << 0,		/* the link is administratively up */
@@ -268,6 +332,81 @@ struct packet_buffer {
     uint8_t *buffer;    /* raw packet to be sent from the DAIM OS switch application / raw packet to be collected by the DAIM OS switch application */
 };
 
+/* structure for a single field of a table entry structure */
+struct daim_table_field {
+    uint16_t offset;    /* byte offset of the field in the table entry structure, i.e. offsetof */
+    uint16_t len;       /* size of the field in bytes */
+};
+
+/*
+    structure for a single query condition
+    fields of 1, 2, 4 or 8 bytes are compared as unsigned integers, other fields up to QUERY_VALUE_LEN bytes are compared byte by byte and only support QUERY_EQ and QUERY_NE
+    conditions on fields longer than QUERY_VALUE_LEN bytes are rejected
+*/
+struct daim_query_condition {
+    struct daim_table_field field;      /* entry field to test */
+    uint8_t op;                         /* one of daim_query_op */
+    uint8_t value[QUERY_VALUE_LEN];     /* value to test against, integers in host byte order */
+};
+
+/* structure describing a filtered and projected read of a DAIM OS table */
+struct daim_table_query {
+    uint8_t table;                              /* one of daim_table */
+    uint16_t num_of_conditions;                 /* number of conditions, all conditions must hold for an entry to match */
+    struct daim_query_condition *conditions;    /* conditions array */
+    uint16_t num_of_fields;                     /* number of projected fields, zero returns whole entries */
+    struct daim_table_field *fields;            /* projected fields array, returned rows hold these fields back to back in array order */
+};
+
+/* structure for configuring a streaming counter export */
+struct daim_counter_export_config {
+    const struct daim_table_query *query;   /* rows to export, the first num_of_key_fields projected fields are the row key, the rest are uint64_t counters */
+    uint16_t num_of_key_fields;             /* number of projected fields forming the row key, i.e. the match fields of a packet forwarding table entry */
+    uint8_t target;                         /* one of daim_export_target */
+    uint8_t path[DESC_STR_LEN];             /* shared memory object name or file path */
+    uint64_t interval;                      /* sampling interval in microseconds */
+    uint64_t ring_size;                     /* size of the shared memory ring data in bytes, unused for EXPORT_FILE */
+    uint32_t keyframe_interval;             /* number of samples between keyframes, zero for the first sample only which is only valid for EXPORT_FILE */
+};
+
+/*
+    structure for a single counter export sample
+    a keyframe's data starts with num_of_columns daim_table_field structures describing the entry field of each column of the table in the sample header
+    the data then holds one column per projected field, each column holding num_of_rows values in row key order
+    the first num_of_key_columns columns form the row key, rows are ordered by the first key column, then by the next key column and so on
+    key columns of 1, 2, 4 or 8 bytes are ordered as unsigned integers, other key columns byte by byte
+    key columns hold raw field values of the size given by their daim_table_field, counter columns hold each value as a zigzag LEB128 varint
+    counter values are the difference from the same row in the previous sample, or absolute values when SAMPLE_KEYFRAME is set
+    a sample is a keyframe whenever the set of row keys changes, a reader decodes samples starting from a keyframe
+*/
+struct daim_counter_sample {
+    uint64_t len;                   /* size of the sample in bytes including this header */
+    uint64_t sequence;              /* sample number, incremented by one for every sample */
+    uint64_t timestamp;             /* UNIX time in nanoseconds (UTC) at which every counter of the sample was read */
+    uint32_t num_of_rows;           /* number of rows */
+    uint16_t num_of_columns;        /* number of columns */
+    uint16_t num_of_key_columns;    /* number of leading columns forming the row key */
+    uint8_t table;                  /* one of daim_table the rows are read from */
+    uint8_t flags;                  /* bitmap of daim_counter_sample_flag */
+    uint8_t data[];                 /* column descriptors in keyframes, then columns array */
+};
+
+/*
+    structure for the shared memory ring of EXPORT_SHM_RING
+    samples never wrap, a sample which does not fit before the end of the data is written at offset zero
+    the writer stores generation + 1 (odd) before changing the data, head or sequence, and generation + 2 (even) after
+    all stores to generation have release ordering and every load of generation by a reader has acquire ordering
+    a reader loads generation, retries while it is odd, copies head, sequence and the sample at head, then loads generation again and retries if it has changed
+    readers detect lost samples by a gap in daim_counter_sample sequence and resume decoding from the next keyframe
+*/
+struct daim_counter_ring {
+    uint64_t generation;    /* seqlock counter, odd while the writer is updating the ring */
+    uint64_t size;          /* size of the sample data in bytes */
+    uint64_t head;          /* offset in the sample data of the most recent complete sample */
+    uint64_t sequence;      /* sequence of the most recent complete sample */
+    uint8_t data[];         /* daim_counter_sample records */
+};
+
 /* DAIM OS information tables */
 
 /* DAIM OS description table (read only) */
@@ -368,6 +507,44 @@ struct switch_link_table_entry {
     uint64_t duration;                  /* duration of the link from the last up state */
 };
 
+/* DAIM OS datapath worker description table (read only) */
+struct worker_table_entry {
+    uint16_t worker_id;                 /* worker number starting from zero */
+    uint16_t cpu;                       /* CPU the worker is bound to */
+    uint32_t queue_depth;               /* number of packets waiting in the worker queue */
+    uint64_t received_packets;          /* number of total packets distributed to the worker */
+    uint64_t processed_packets;         /* number of total packets processed to completion by the worker */
+    uint64_t transmitted_packets;       /* number of total packets transmitted by the worker */
+    uint64_t queue_drops;               /* number of total packets dropped because the worker queue was full */
+    uint64_t no_rule_packets;           /* number of total packets without a matching flow rule */
+    uint64_t busy_time;                 /* time the worker spent processing packets in microseconds */
+    uint64_t duration;                  /* duration of the worker from the most recent start in seconds */
+};
+
+/* DAIM OS switch port egress queue description table (read only) */
+struct port_queue_table_entry {
+    uint16_t port_number;               /* DAIM OS switch port number */
+    uint8_t queue;                      /* queue number starting from zero */
+    uint32_t queue_depth;               /* number of packets waiting in the queue */
+    uint64_t queue_bytes;               /* number of bytes waiting in the queue */
+    uint64_t transmitted_packets;       /* number of total packets transmitted from the queue */
+    uint64_t transmitted_bytes;         /* number of total bytes transmitted from the queue */
+    uint64_t tail_drops;                /* number of total packets dropped because the queue was full */
+    uint64_t shaped_time;               /* time the queue was held back by port shaping in microseconds */
+};
+
+/* DAIM OS IP fragment reassembly description table (read only), available when features contains DAIM_IP_REASM */
+struct ip_reasm_table_entry {
+    uint32_t datagrams;                 /* number of datagrams being reassembled */
+    uint64_t memory_used;               /* bytes of fragments held for reassembly */
+    uint64_t received_fragments;        /* number of total fragments received */
+    uint64_t reassembled_datagrams;     /* number of total datagrams completed, matched and forwarded as their original fragments */
+    uint64_t timeouts;                  /* number of total datagrams dropped by reassembly timeout */
+    uint64_t evictions;                 /* number of total datagrams evicted to stay within the memory budget */
+    uint64_t overlaps;                  /* number of total fragments overlapping already received data */
+    uint64_t drops;                     /* number of total fragments dropped, i.e. malformed, oversized datagram */
+};
+
 /* DAIM OS Network Management tables */
 
 /* DAIM OS packet forwarding table (read and write) */
@@ -424,6 +601,67 @@ struct entity_config_table_entry {
     uint64_t run_out;               	/* number of bytes to shut down the entity */
 };
 
+/*
+    DAIM OS datapath worker configuration table (read and write)
+    received packets are distributed by a hash of hash_fields so all packets of a flow are processed in order by the same worker
+    IP fragments are hashed without HASH_TP_PORT, as only the first fragment carries TCP/UDP ports, so every fragment of a datagram reaches the same worker
+    when every port supports IOCTL_PORT_QUEUES with receive_queues equal to workers, DAIM OS programs the ports with the translated hash_fields and worker n reads receive queue n of every port, HASH_IN_PORT is then not used
+    otherwise packets are read by a single receive stage and distributed to the workers in software
+    every worker parses, looks up, applies actions and transmits its packets to completion, or enqueues them to the egress scheduler of the output port when DAIM_PORT_QOS_CONFIG_TABLE holds an entry for that port
+    signal handlers are called one at a time whatever the number of workers
+*/
+struct worker_config_table_entry {
+    uint16_t workers;               /* number of workers, zero or one for a single worker */
+    uint16_t first_cpu;             /* first CPU workers are bound to */
+    uint16_t num_of_cpus;           /* number of CPUs from first_cpu workers are spread over, zero for all CPUs from first_cpu */
+    uint32_t queue_size;            /* maximum number of packets in a worker queue */
+    uint16_t hash_fields;           /* bitmap of daim_worker_hash_field */
+};
+
+/* structure for settings of a single egress port queue */
+struct port_queue_config {
+    uint8_t scheduling;                 /* one of daim_queue_scheduling */
+    uint8_t weight;                     /* deficit round robin share 1 minimum, 100 maximum, the queue quantum is weight times port_mtu bytes */
+    uint32_t queue_limit;               /* maximum number of packets in the queue */
+};
+
+/*
+    DAIM OS switch port egress scheduler configuration table (read and write)
+    packets are placed in a queue by the VLAN priority of the packet, or by the IP ToS when the packet has no VLAN header, or in default_queue when the packet has neither
+    VLAN priority and IP ToS are read after the actions of the matching flow rule, i.e. PACKET_SET_VLAN_PCP and PACKET_SET_NW_TOS, are applied
+    the port is shaped by a token bucket to shaping_rate, or to port_speed of the switch port configuration when shaping_rate is zero
+    the queues are kept in software, every datapath worker enqueues to them and a single transmit stage per port drains them in scheduling order
+    the transmit stage writes to transmit queue zero of the port, other transmit queues of IOCTL_PORT_QUEUES are not used for the port while the entry exists
+    a write fails when default_queue or any entry of vlan_pcp_queue or ip_dscp_queue is not below num_of_queues, or when a non-zero burst_size is below port_mtu
+*/
+struct switch_port_qos_config_table_entry {
+    uint16_t port_number;                           /* DAIM OS switch port number */
+    uint8_t num_of_queues;                          /* number of queues up to PORT_QUEUES_MAX */
+    uint8_t default_queue;                          /* queue for packets without VLAN header which are not IP, i.e. ARP, STP */
+    uint8_t vlan_pcp_queue[VLAN_PCP_VALUES];        /* queue for each VLAN priority */
+    uint8_t ip_dscp_queue[IP_DSCP_VALUES];          /* queue for each IP ToS (DSCP field, 6 bits) */
+    uint64_t shaping_rate;                          /* port shaping rate in bits per second */
+    uint64_t burst_size;                            /* token bucket depth in bytes, zero for the larger of port_mtu and one millisecond at the shaping rate */
+    struct port_queue_config queues[PORT_QUEUES_MAX];   /* settings of each queue */
+};
+
+/*
+    DAIM OS IP fragment reassembly configuration table (read and write)
+    available when features of the DAIM OS description table contains DAIM_IP_REASM
+    fragments are tracked by IP source, IP destination, IP identification and IP protocol and chained without copying
+    reassembly runs after distribution in the datapath worker selected for the fragments, each worker keeping its own datagrams and an equal share of memory_limit and max_datagrams
+    a reassembled datagram is matched against the packet forwarding table with its TCP/UDP ports
+    the original fragments are then forwarded with the actions of the matching flow rule, so no egress port_mtu is exceeded
+    the least recently updated datagram is evicted when a new fragment would exceed memory_limit or start a datagram beyond max_datagrams
+*/
+struct ip_reasm_config_table_entry {
+    uint8_t enabled;                    /* non-zero to reassemble fragments before matching */
+    uint64_t memory_limit;              /* maximum bytes of fragments held for reassembly */
+    uint32_t max_datagrams;             /* maximum number of datagrams being reassembled */
+    uint32_t timeout;                   /* time to complete a datagram from its first fragment in milliseconds */
+    uint8_t overlap;                    /* one of daim_reasm_overlap */
+};
+
 /* DAIM OS switch link configuration table (read and write) */
 struct switch_link_config_table_entry {
     uint64_t id;                            /* link id as assigned by DAIM OS and DAIM cloud */
@@ -438,6 +676,12 @@ struct switch_link_config_table_entry {
 
 #pragma pack(pop)
 
+/* opaque per-reader table cursor returned by daim_cursor_open */
+struct daim_table_cursor;
+
+/* opaque counter export returned by daim_export_start */
+struct daim_counter_export;
+
 /* DAIM OS API function prototypes (DAIM applications to DAIM OS) */
 
 /*
@@ -465,6 +709,7 @@ extern uint16_t daim_table_write (uint8_t table, void *entry, uint32_t size, uin
 
 /*
     reads an entry from one of the DAIM OS tables listed in daim_table and returns a buffer of the respective table entry formatted according to the respective table entry structure
+    the entry indicator is shared by every caller reading the table, use daim_cursor_open for an independent reader
     if the function is successful then entry indicator is incremented
     entry argument used for reading specific entries
     size is the size of the entry buffer in bytes
@@ -480,11 +725,70 @@ extern void *daim_table_read (uint8_t table, void *entry, uint32_t size);
 */
 extern void daim_table_rewind (uint8_t table);
 
+/*
+    opens an independent cursor over one of the DAIM OS tables listed in daim_table
+    the cursor reads a consistent snapshot of the table as it was when the cursor was opened or last rewound
+    readers never block each other or daim_table_write, entries removed by a writer are reclaimed once no open cursor refers to them
+    a cursor must only be used by one thread at a time
+    returns null on failure
+*/
+extern struct daim_table_cursor *daim_cursor_open (uint8_t table);
+
+/*
+    reads the next entry of the snapshot held by cursor, in the same format as daim_table_read
+    cursors opened by daim_cursor_query return the next matching row formatted by the query projection
+    if the function is successful then the cursor is moved to the following entry
+    returned buffer should be deallocated after use
+    returns null if error occurs, i.e. end of the snapshot
+*/
+extern void *daim_cursor_read (struct daim_table_cursor *cursor);
+
+/*
+    moves cursor to the beginning of a fresh snapshot of its table
+    other cursors and the shared entry indicator of daim_table_read are not affected
+*/
+extern void daim_cursor_rewind (struct daim_table_cursor *cursor);
+
+/*
+    closes cursor and releases the snapshot held by it
+*/
+extern void daim_cursor_close (struct daim_table_cursor *cursor);
+
+/*
+    opens a cursor over the entries of query->table matching every condition in query
+    matching and projection are done inside DAIM OS, daim_cursor_read then returns projected rows instead of whole entries
+    conditions testing indexed fields are looked up without scanning the table
+    returns null on failure, i.e. unknown table, field outside of the entry structure, condition field longer than QUERY_VALUE_LEN, unsupported op for the field size
+*/
+extern struct daim_table_cursor *daim_cursor_query (const struct daim_table_query *query);
+
+/*
+    builds a secondary index over field of one of the DAIM OS tables listed in daim_table
+    entity id, MAC address, IP address, switch port number and link endpoints are indexed by default
+    returns zero if successful
+    one is returned on failure
+*/
+extern uint16_t daim_table_index (uint8_t table, const struct daim_table_field *field);
+
+/*
+    starts sampling the counters selected by config->query every config->interval microseconds
+    every sample is read from a single table snapshot and written to config->path as a daim_counter_sample
+    returns null on failure, i.e. invalid query, zero num_of_key_fields, a counter field which is not 8 bytes, zero keyframe_interval with EXPORT_SHM_RING, path cannot be created
+*/
+extern struct daim_counter_export *daim_export_start (const struct daim_counter_export_config *config);
+
+/*
+    stops the counter export and releases the resources associated with it
+    the shared memory object or file is left in place
+*/
+extern void daim_export_stop (struct daim_counter_export *counter_export);
+
 /*
     attach a callback function for a specified DAIM OS signal emission
     sig_type argument is one of the daim_signal_number
     handler is a function of void callback_function (uint16_t sig_num, void *data) type
     sig_num can be found in daim_signal_number
+    handlers are called one at a time, also when several datapath workers are configured in DAIM_WORKER_CONFIG_TABLE
 */
 extern void daim_signal (uint16_t sig_type, sighandler handler);
 
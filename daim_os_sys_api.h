@@ -31,7 +31,8 @@ enum daim_switch_management {
 	IOCTL_SWITCH_INFO,
 	IOCTL_SWITCH_POWER,
 	IOCTL_PORT_STATE,
-	IOCTL_PORT_CONTROL
+	IOCTL_PORT_CONTROL,
+	IOCTL_PORT_QUEUES
 };
 
 /* Capabilities of DAIM OS switch */
@@ -40,6 +41,14 @@ enum daim_switch_capability {
     IP_REASM = 1 << 1   /* Can reassemble IP fragments */
 };
 
+/* to be used for encoding or decoding hash_fields in switch_port_queues structure */
+enum port_queue_hash {
+    QUEUE_HASH_MAC_ADDR = 1 << 0,   /* source and destination Ethernet address */
+    QUEUE_HASH_IP_ADDR = 1 << 1,    /* source and destination IP address */
+    QUEUE_HASH_IP_PROTO = 1 << 2,   /* IP protocol */
+    QUEUE_HASH_TP_PORT = 1 << 3     /* TCP/UDP source and destination port, ignored for IP fragments */
+};
+
 /* to be used for encoding or decoding power in switch_port_control and switch_port_state structure */
 enum device_power {
     ON = 0xfa,
@@ -103,6 +112,14 @@ struct switch_port_control {
 	uint64_t speed;
 };
 
+/* structure for data argument to be used with IOCTL_PORT_QUEUES request_code */
+struct switch_port_queues {
+	uint8_t mac_addr[MAC_ADDR_LEN];
+	uint16_t receive_queues;		/* number of receive queues, filled by the device when zero */
+	uint16_t transmit_queues;		/* number of transmit queues, filled by the device when zero */
+	uint16_t hash_fields;			/* bitmap of port_queue_hash flags hashed by the device to select a receive queue */
+};
+
 /* System API for DAIM OS (network device software interface for DAIM OS) */
 
 /*
@@ -122,6 +139,20 @@ extern int daim_port_read (uint8_t mac_addr[MAC_ADDR_LEN], void *buffer, uint64_
 */
 extern int daim_port_write (uint8_t mac_addr[MAC_ADDR_LEN], const void *buffer, uint64_t size);
 
+/*
+    same as daim_port_read but reads only from the receive queue specified in queue
+    queues are configured with IOCTL_PORT_QUEUES and each queue may be read from a different thread
+    returns negative if error occurs
+*/
+extern int daim_port_read_queue (uint8_t mac_addr[MAC_ADDR_LEN], uint16_t queue, void *buffer, uint64_t size);
+
+/*
+    same as daim_port_write but writes to the transmit queue specified in queue
+    each queue may be written from a different thread
+    returns negative if error occurs
+*/
+extern int daim_port_write_queue (uint8_t mac_addr[MAC_ADDR_LEN], uint16_t queue, const void *buffer, uint64_t size);
+
 /*
     manipulates the underlying DAIM OS switch parameters
     request_code determines type of request to the device